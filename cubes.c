@@ -10,6 +10,7 @@
 #include "cube_t.h"
 #include "defs.h"
 #include "hash.h"
+#include "hugealloc.h"
 #include "rotations.h"
 
 #define HASH_SIZE 4096
@@ -17,7 +18,10 @@
 struct cube_stat {
     atomic_size_t count;
     struct hash cube_hash;
-    cube_t *cube_list;
+
+    /* Densely packed cubes of this size, each occupying exactly (size) coords
+     * with no padding out to MAX_DIM. */
+    struct huge_buf cube_list;
 };
 
 static struct cube_stat all_cubes[MAX_DIM];
@@ -135,7 +139,7 @@ static void normalize_cube(const struct cube_coords *coords,
     }
 }
 
-static void find_next_cubes_for_cube(const cube_t *cube, size_t size,
+static void find_next_cubes_for_cube(const coord_t (*cube)[3], size_t size,
         struct cube_stat *next_stat) {
     /* Generate regular and shifted coordinates structures from polycube. There
      * will be 3 shifted polycubes each shifted 1 in a positive direction to
@@ -148,9 +152,9 @@ static void find_next_cubes_for_cube(const cube_t *cube, size_t size,
     coord_t max_y = 0;
     coord_t max_z = 0;
     for (size_t i = 0; i < size; i++) {
-        coord_t x = cube->coords[i][0];
-        coord_t y = cube->coords[i][1];
-        coord_t z = cube->coords[i][2];
+        coord_t x = cube[i][0];
+        coord_t y = cube[i][1];
+        coord_t z = cube[i][2];
         coord_set(&orig, x, y, z);
         coord_set(&shifted_x, x + 1, y, z);
         coord_set(&shifted_y, x, y + 1, z);
@@ -179,8 +183,9 @@ static void find_next_cubes_for_cube(const cube_t *cube, size_t size,
     shifted_z.z_len = max_z + 2;
 
     /* Allocate heap space for normalized cube since they are ultimately
-     * placed into the map. */
-    cube_t *normalized = malloc(sizeof(*normalized));
+     * placed into the map. Only allocate as many coords as the next size
+     * needs. */
+    coord_t (*normalized)[3] = malloc((size + 1) * sizeof(*normalized));
     if (!normalized) {
         perror("malloc normalized");
         exit(EXIT_FAILURE);
@@ -241,9 +246,9 @@ static void find_next_cubes_for_cube(const cube_t *cube, size_t size,
                     for (size_t y = 0; y < normalized_coords.y_len; y++) {
                         for (size_t z = 0; z < normalized_coords.z_len; z++) {
                             if (coord_get(&normalized_coords, x, y, z)) {
-                                normalized->coords[coord_idx][0] = x;
-                                normalized->coords[coord_idx][1] = y;
-                                normalized->coords[coord_idx][2] = z;
+                                normalized[coord_idx][0] = x;
+                                normalized[coord_idx][1] = y;
+                                normalized[coord_idx][2] = z;
                                 coord_idx++;
                                 if (coord_idx >= size + 1) {
                                     break;
@@ -255,17 +260,16 @@ static void find_next_cubes_for_cube(const cube_t *cube, size_t size,
 
                 /* Try to insert normalized cube into the tree for the next
                  * size. */
-                cube_t *inserted =
-                    hash_search(&next_stat->cube_hash, normalized->coords,
-                            (size + 1) * sizeof(*normalized->coords),
-                            normalized);
+                coord_t (*inserted)[3] =
+                    hash_search(&next_stat->cube_hash, normalized,
+                            (size + 1) * sizeof(*normalized), normalized);
                 if (!inserted) {
                     perror("hash_search normalized");
                     exit(EXIT_FAILURE);
                 }
                 if (inserted == normalized) {
                     /* If inserted, allocate a new normalized cube buffer. */
-                    normalized = malloc(sizeof(*normalized));
+                    normalized = malloc((size + 1) * sizeof(*normalized));
                     if (!normalized) {
                         perror("malloc normalized");
                         exit(EXIT_FAILURE);
@@ -283,14 +287,13 @@ static void find_next_cubes_for_cube(const cube_t *cube, size_t size,
 }
 
 struct flatten_hash_callback_aux {
-    cube_t *list;
+    coord_t (*list)[3];
 };
 static void flatten_hash_callback(const void *coords UNUSED,
-        size_t coords_len UNUSED, void *cube_, void *aux_) {
-    cube_t *cube = cube_;
+        size_t coords_len, void *cube, void *aux_) {
     struct flatten_hash_callback_aux *aux = aux_;
-    *aux->list = *cube;
-    aux->list++;
+    memcpy(aux->list, cube, coords_len);
+    aux->list += coords_len / sizeof(*aux->list);
     free(cube);
 }
 
@@ -305,19 +308,24 @@ static void find_next_cubes_for_size(size_t size) {
     }
 
     /* Find next cubes. */
+    const coord_t (*cur_list)[3] = cur_stat->cube_list.ptr;
+    size_t cur_count = cur_stat->count;
 #pragma omp parallel for
-    for (size_t i = 0; i < cur_stat->count; i++) {
-        find_next_cubes_for_cube(&cur_stat->cube_list[i], size, next_stat);
+    for (size_t i = 0; i < cur_count; i++) {
+        find_next_cubes_for_cube(&cur_list[i * size], size, next_stat);
     }
 
+    /* The current size has been fully expanded, so give its pages back. */
+    huge_release(&cur_stat->cube_list);
+
     /* Flatten hash into an array and destroy the hash. */
-    next_stat->cube_list = malloc(next_stat->count * sizeof(cube_t));
-    if (!next_stat->cube_list) {
-        perror("malloc next_stat cube_list");
+    if (huge_alloc(&next_stat->cube_list,
+                next_stat->count * (size + 1) * sizeof(*cur_list))) {
+        perror("huge_alloc next_stat cube_list");
         exit(EXIT_FAILURE);
     }
     struct flatten_hash_callback_aux flatten_hash_callback_aux = {
-        .list = next_stat->cube_list,
+        .list = next_stat->cube_list.ptr,
     };
     hash_free(&next_stat->cube_hash, flatten_hash_callback,
             &flatten_hash_callback_aux);
@@ -346,17 +354,16 @@ int main(int argc, char **argv) {
     }
 
     /* First polycube: 1x1x1 single cube. */
-    cube_t *first_cube = malloc(sizeof(cube_t));
-    if (!first_cube) {
-        perror("malloc first cube");
+    if (huge_alloc(&all_cubes[0].cube_list, sizeof(coord_t[1][3]))) {
+        perror("huge_alloc first cube");
         exit(EXIT_FAILURE);
     }
-    *first_cube = (cube_t) {
-        .coords = { { 0, 0, 0 } },
-    };
+    coord_t (*first_cube)[3] = all_cubes[0].cube_list.ptr;
+    first_cube[0][0] = 0;
+    first_cube[0][1] = 0;
+    first_cube[0][2] = 0;
 
     /* Add first cube to list. */
-    all_cubes[0].cube_list = first_cube;
     all_cubes[0].count = 1;
     printf("%2d: %zu\n", 1, all_cubes[0].count);
 
@@ -369,7 +376,7 @@ int main(int argc, char **argv) {
 
     /* Free resources. */
     for (size_t size = 1; size <= max_size; size++) {
-        free(all_cubes[size - 1].cube_list);
+        huge_free(&all_cubes[size - 1].cube_list);
     }
 
     return 0;
@@ -0,0 +1,103 @@
+#define _DEFAULT_SOURCE
+#include "hugealloc.h"
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define HUGE_PAGE_SIZE ((size_t) 2 * 1024 * 1024)
+
+static size_t round_up(size_t len, size_t align) {
+    return (len + align - 1) / align * align;
+}
+
+int huge_alloc(struct huge_buf *buf, size_t len) {
+    int ret;
+
+    *buf = (struct huge_buf) {
+        .ptr = NULL,
+    };
+
+    /* Buffers smaller than a hugepage get ordinary pages. */
+    if (len < HUGE_PAGE_SIZE) {
+        long page_size = sysconf(_SC_PAGESIZE);
+        if (page_size <= 0) {
+            page_size = 4096;
+        }
+        buf->len = round_up(len ? len : 1, page_size);
+        buf->ptr = mmap(NULL, buf->len, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (buf->ptr == MAP_FAILED) {
+            buf->ptr = NULL;
+            ret = -1;
+            goto exit;
+        }
+        ret = 0;
+        goto exit;
+    }
+
+    buf->len = round_up(len, HUGE_PAGE_SIZE);
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    /* Try explicitly reserved hugepages first. This fails unless the system
+     * has hugepages set aside, in which case we fall back below. Ask for 2 MiB
+     * pages explicitly, since the default hugetlb size may be larger and our
+     * lengths are only rounded to 2 MiB. */
+    buf->ptr = mmap(NULL, buf->len, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT),
+            -1, 0);
+    if (buf->ptr != MAP_FAILED) {
+        ret = 0;
+        goto exit;
+    }
+#endif
+
+    /* Map an extra hugepage so that we can trim the mapping down to a
+     * hugepage-aligned region, which transparent hugepages require. */
+    size_t map_len = buf->len + HUGE_PAGE_SIZE;
+    unsigned char *map = mmap(NULL, map_len, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+        buf->ptr = NULL;
+        ret = -1;
+        goto exit;
+    }
+    unsigned char *aligned =
+        (unsigned char *) round_up((uintptr_t) map, HUGE_PAGE_SIZE);
+    if (aligned != map) {
+        munmap(map, aligned - map);
+    }
+    if (aligned + buf->len != map + map_len) {
+        munmap(aligned + buf->len, map + map_len - (aligned + buf->len));
+    }
+    buf->ptr = aligned;
+
+#ifdef MADV_HUGEPAGE
+    /* Advisory only; ignore failure if THP is disabled. */
+    madvise(buf->ptr, buf->len, MADV_HUGEPAGE);
+#endif
+
+    ret = 0;
+    goto exit;
+
+exit:
+    return ret;
+}
+
+void huge_release(struct huge_buf *buf) {
+    if (!buf->ptr) {
+        return;
+    }
+
+    /* Drop the backing pages but keep the mapping. This is best-effort, since
+     * older kernels reject MADV_DONTNEED on hugetlb mappings. */
+    madvise(buf->ptr, buf->len, MADV_DONTNEED);
+}
+
+void huge_free(struct huge_buf *buf) {
+    if (!buf->ptr) {
+        return;
+    }
+
+    munmap(buf->ptr, buf->len);
+    buf->ptr = NULL;
+}
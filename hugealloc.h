@@ -0,0 +1,15 @@
+#ifndef HUGEALLOC_H
+#define HUGEALLOC_H
+
+#include <stddef.h>
+
+struct huge_buf {
+    void *ptr;
+    size_t len;
+};
+
+int huge_alloc(struct huge_buf *buf, size_t len);
+void huge_release(struct huge_buf *buf);
+void huge_free(struct huge_buf *buf);
+
+#endif